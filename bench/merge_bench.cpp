@@ -0,0 +1,108 @@
+// 分片合并耗时基准：生成分片文件后分别用各合并方式拼成目标文件并计时
+//
+//   cmake -DBUILD_BENCHMARKS=ON .. && make MergeBench
+//   ./MergeBench --bench_dir=/mnt/xfs/bench --bench_size_gb=20 --bench_parts=16
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Downloader/FileMerger.hpp"
+#include "logger.hpp"
+
+DEFINE_string(custom_tbb_parallel_control, "",
+              "TBB arena concurrency control, e.g. merge:8");
+DEFINE_string(bench_dir, ".", "Directory for part and output files");
+DEFINE_double(bench_size_gb, 20, "Total size of the merged file in GiB");
+DEFINE_int32(bench_parts, 16, "Number of part files");
+
+namespace {
+
+constexpr uint64_t kAlign = 64 * 1024;
+
+double secondsSince(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+bool writePart(const std::string& path, uint64_t length, int seed) {
+  std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+  std::vector<char> buf(8 << 20);
+  for (size_t i = 0; i < buf.size(); ++i) {
+    buf[i] = static_cast<char>((i * 131 + seed) & 0xff);
+  }
+  for (uint64_t done = 0; done < length && ofs;) {
+    uint64_t n = std::min<uint64_t>(buf.size(), length - done);
+    ofs.write(buf.data(), static_cast<std::streamsize>(n));
+    done += n;
+  }
+  return static_cast<bool>(ofs);
+}
+
+// 旧实现：逐个分片经用户态流式拷贝
+void streamMerge(const std::string& dest, const std::vector<MergePart>& parts) {
+  std::ofstream ofs(dest, std::ios::binary);
+  for (const auto& part : parts) {
+    std::ifstream ifs(part.path, std::ios::binary);
+    ofs << ifs.rdbuf();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  uint64_t total =
+      static_cast<uint64_t>(FLAGS_bench_size_gb * 1024 * 1024 * 1024);
+  int count = std::max(1, FLAGS_bench_parts);
+  uint64_t partSize = total / count / kAlign * kAlign;
+
+  std::vector<MergePart> parts;
+  std::cout << "Writing " << count << " parts, " << total << " bytes total"
+            << std::endl;
+  for (int i = 0; i < count; ++i) {
+    MergePart part;
+    part.path = FLAGS_bench_dir + "/bench.part" + std::to_string(i);
+    part.offset = i * partSize;
+    part.length = (i == count - 1) ? total - part.offset : partSize;
+    if (!writePart(part.path, part.length, i)) {
+      std::cerr << "Failed to write " << part.path << std::endl;
+      return 1;
+    }
+    parts.push_back(part);
+  }
+
+  std::string dest = FLAGS_bench_dir + "/bench.out";
+  double gib = static_cast<double>(total) / (1024 * 1024 * 1024);
+  auto report = [&](const char* name, double seconds) {
+    std::cout << name << ": " << seconds << " s (" << gib / seconds
+              << " GiB/s)" << std::endl;
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  streamMerge(dest, parts);
+  report("stream (serial ofs << rdbuf)", secondsSince(begin));
+
+  for (auto method : {MergeMethod::ReadWrite, MergeMethod::CopyFileRange,
+                      MergeMethod::Reflink}) {
+    std::remove(dest.c_str());
+    begin = std::chrono::steady_clock::now();
+    bool ok = FileMerger::Merge(dest, parts, method);
+    report(MergeMethodName(method), secondsSince(begin));
+    if (!ok) std::cerr << "  merge failed" << std::endl;
+  }
+
+  std::remove(dest.c_str());
+  for (const auto& part : parts) {
+    std::remove(part.path.c_str());
+  }
+  return 0;
+}
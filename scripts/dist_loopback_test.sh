@@ -0,0 +1,194 @@
+#!/usr/bin/env bash
+# 分布式下载的本地多进程测试：在回环地址上起一个支持 Range 的 HTTP 服务
+# （python3 -m http.server 不支持 Range，这里内置一个带限速的版本），
+# 然后覆盖正常下载、连续 kill -9 工作进程后的续传、SIGSTOP 工作进程时的退出，
+# 以及 404 时不留下输出文件几种情况。
+#
+# 用法：scripts/dist_loopback_test.sh <path/to/DownloaderApp>
+
+set -u
+
+APP=$(realpath "${1:?usage: $0 <path/to/DownloaderApp>}")
+WORK=$(mktemp -d)
+PORT=${PORT:-18990}
+SLOW_PORT=$((PORT + 1))
+FAILED=0
+PIDS=()
+
+cleanup() {
+  for pid in "${PIDS[@]}"; do kill -9 "$pid" 2>/dev/null; done
+  wait 2>/dev/null
+  rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+cat > "$WORK/range_server.py" <<'EOF'
+import http.server, os, re, socketserver, sys, time
+
+ROOT, PORT, RATE = sys.argv[1], int(sys.argv[2]), int(sys.argv[3])
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def _path(self):
+        path = os.path.join(ROOT, self.path.lstrip("/"))
+        return path if os.path.isfile(path) else None
+
+    def _not_found(self):
+        self.send_response(404)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def do_HEAD(self):
+        path = self._path()
+        if not path:
+            return self._not_found()
+        self.send_response(200)
+        self.send_header("Content-Length", str(os.path.getsize(path)))
+        self.send_header("Accept-Ranges", "bytes")
+        self.end_headers()
+
+    def do_GET(self):
+        path = self._path()
+        # 存在 <name>.404 标记时 HEAD 照常返回大小，只有 GET 返回 404
+        if not path or os.path.exists(path + ".404"):
+            return self._not_found()
+        size = os.path.getsize(path)
+        start, end, code = 0, size - 1, 200
+        m = re.match(r"bytes=(\d+)-(\d*)", self.headers.get("Range", ""))
+        if m:
+            start = int(m.group(1))
+            end = int(m.group(2)) if m.group(2) else size - 1
+            code = 206
+        self.send_response(code)
+        self.send_header("Content-Length", str(end - start + 1))
+        if code == 206:
+            self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+        self.end_headers()
+        step = 16384
+        with open(path, "rb") as f:
+            f.seek(start)
+            left = end - start + 1
+            while left > 0:
+                data = f.read(min(step, left))
+                self.wfile.write(data)
+                left -= len(data)
+                if RATE:
+                    time.sleep(len(data) / RATE)
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+Server(("127.0.0.1", PORT), Handler).serve_forever()
+EOF
+
+mkdir -p "$WORK/www" "$WORK/run"
+head -c 6000000 /dev/urandom > "$WORK/www/file.bin"
+# 404 场景：HEAD 能拿到大小，GET 返回 404
+head -c 3000000 /dev/urandom > "$WORK/www/gone.bin"
+touch "$WORK/www/gone.bin.404"
+
+python3 "$WORK/range_server.py" "$WORK/www" "$PORT" 0 2>/dev/null &
+PIDS+=($!)
+python3 "$WORK/range_server.py" "$WORK/www" "$SLOW_PORT" 1000000 2>/dev/null &
+PIDS+=($!)
+sleep 1
+
+cd "$WORK/run" || exit 1
+
+pass() { echo "PASS: $1"; }
+fail() { echo "FAIL: $1"; FAILED=1; }
+
+wait_for_socket() {
+  for _ in $(seq 1 50); do
+    [ -S "$1" ] && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+# 1. 协调者自行拉起工作进程，正常完成
+"$APP" "http://127.0.0.1:$PORT/file.bin" out1.bin --dist_role=coordinator \
+  --dist_workers=3 --lease_size=500000 > log1.txt
+if [ $? -eq 0 ] && cmp -s out1.bin "$WORK/www/file.bin"; then
+  pass "spawned workers"
+else
+  fail "spawned workers"
+fi
+
+# 2. 单个租约，连续两次 kill -9 持有它的工作进程，第三个工作进程续传完成
+"$APP" "http://127.0.0.1:$SLOW_PORT/file.bin" out2.bin \
+  --dist_role=coordinator --dist_socket="$WORK/c2.sock" \
+  --lease_size=6000000 > log2.txt &
+COORD=$!
+PIDS+=($COORD)
+wait_for_socket "$WORK/c2.sock"
+# 工作进程在另一个目录启动，验证下发的是绝对路径
+cd "$WORK" || exit 1
+for _ in 1 2; do
+  "$APP" --dist_role=worker --dist_socket="$WORK/c2.sock" > /dev/null &
+  W=$!
+  sleep 2
+  kill -9 "$W"
+  wait "$W" 2>/dev/null
+done
+"$APP" --dist_role=worker --dist_socket="$WORK/c2.sock" > /dev/null
+cd "$WORK/run" || exit 1
+wait "$COORD"
+RC=$?
+# 两次回收的起点必须递增，说明第二个工作进程的进度没有丢
+STARTS=$(grep -o "Reassigning lease 0 from byte [0-9]*" log2.txt |
+  awk '{print $NF}')
+FIRST=$(echo "$STARTS" | sed -n 1p)
+SECOND=$(echo "$STARTS" | sed -n 2p)
+if [ $RC -eq 0 ] && cmp -s out2.bin "$WORK/www/file.bin" &&
+  [ -n "$SECOND" ] && [ "$SECOND" -gt "$FIRST" ]; then
+  pass "reassignment after kill -9 (resumed from $FIRST, then $SECOND)"
+else
+  fail "reassignment after kill -9 (rc=$RC, starts: $STARTS)"
+fi
+
+# 3. 拉起的工作进程被 SIGSTOP，租约超时回收后其余进程完成，协调者仍能退出
+"$APP" "http://127.0.0.1:$SLOW_PORT/file.bin" out3.bin \
+  --dist_role=coordinator --dist_workers=2 --lease_size=1000000 \
+  --lease_timeout_ms=2000 > log3.txt &
+COORD=$!
+PIDS+=($COORD)
+sleep 1.5
+STOPPED=$(pgrep -P "$COORD" | head -1)
+[ -n "$STOPPED" ] && kill -STOP "$STOPPED"
+RC=124
+for _ in $(seq 1 60); do
+  if ! kill -0 "$COORD" 2>/dev/null; then
+    wait "$COORD"
+    RC=$?
+    break
+  fi
+  sleep 1
+done
+if [ $RC -eq 0 ] && cmp -s out3.bin "$WORK/www/file.bin" &&
+  grep -q "heartbeat timed out" log3.txt; then
+  pass "shutdown with a stopped worker"
+else
+  fail "shutdown with a stopped worker (rc=$RC)"
+  kill -9 "$COORD" 2>/dev/null
+fi
+
+# 4. HEAD 成功但 GET 返回 404：工作进程上报不可重试的 FAIL，协调者退出码非 0，
+#    且删除已预分配的临时文件，不留下目标文件
+"$APP" "http://127.0.0.1:$PORT/gone.bin" out4.bin --dist_role=coordinator \
+  --dist_workers=2 --lease_size=1000000 > log4.txt
+RC=$?
+if [ $RC -ne 0 ] && [ ! -e out4.bin ] && [ ! -e out4.bin.dist ] &&
+  grep -q "3000000 bytes in 3 leases" log4.txt &&
+  grep -q "failed on pid .*(http 404, attempt 1)" log4.txt; then
+  pass "no output on 404"
+else
+  fail "no output on 404 (rc=$RC)"
+fi
+
+exit $FAILED
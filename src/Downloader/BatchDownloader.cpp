@@ -0,0 +1,292 @@
+#include "BatchDownloader.hpp"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <system_error>
+
+#include "CurlCommon.hpp"
+#include "logger.hpp"
+
+DECLARE_int32(download_threads);
+DECLARE_int32(batch_concurrency);
+DECLARE_int32(max_host_connections);
+DECLARE_int64(small_file_threshold);
+
+namespace {
+
+constexpr long kMaxPollTimeoutMs = 1000;
+constexpr uint64_t kProgressEveryFiles = 1000;
+
+// 清单中的目标路径可以带尚不存在的子目录
+void createParentDirs(const std::string& path) {
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(parent, ec);
+  }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       begin)
+      .count();
+}
+
+}  // namespace
+
+BatchDownloader::BatchDownloader(Downloader& downloader)
+    : downloader_(downloader), retryPolicy_(RetryPolicy::FromFlags()) {
+  multi_ = curl_multi_init();
+  // HTTP/2 时同一主机的请求多路复用到一条连接上，
+  // HTTP/1.1 时按主机限制连接数并复用长连接
+  curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                    static_cast<long>(std::max(1, FLAGS_max_host_connections)));
+  curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS,
+                    static_cast<long>(std::max(1, FLAGS_batch_concurrency)));
+}
+
+BatchDownloader::~BatchDownloader() {
+  for (auto& kv : active_) {
+    curl_multi_remove_handle(multi_, kv.first);
+    curl_easy_cleanup(kv.first);
+  }
+  for (CURL* curl : idleHandles_) {
+    curl_easy_cleanup(curl);
+  }
+  curl_multi_cleanup(multi_);
+}
+
+size_t BatchDownloader::writeCallback(void* ptr, size_t size, size_t nmemb,
+                                      void* userdata) {
+  Transfer* transfer = static_cast<Transfer*>(userdata);
+  if (!transfer->ofs.is_open()) {
+    // 第一次回调时响应头已就绪，据此决定是否转为分片下载
+    curl_off_t length = -1;
+    curl_easy_getinfo(transfer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                      &length);
+    if (length > transfer->threshold) {
+      transfer->large = true;
+      return 0;
+    }
+    createParentDirs(transfer->dest);
+    transfer->ofs.open(transfer->tempPath(),
+                       std::ios::binary | std::ios::trunc);
+    if (!transfer->ofs) return 0;
+  }
+  transfer->ofs.write(static_cast<char*>(ptr), size * nmemb);
+  if (!transfer->ofs) return 0;
+  transfer->received += size * nmemb;
+  return size * nmemb;
+}
+
+bool BatchDownloader::readEntry(std::ifstream& list, std::string& url,
+                                std::string& dest) {
+  std::string line;
+  while (std::getline(list, line)) {
+    ++lineNo_;
+    std::istringstream iss(line);
+    if (!(iss >> url) || url[0] == '#') continue;  // 空行或注释
+    if (!(iss >> dest)) {
+      LOG(ERROR) << "[Batch] Line " << lineNo_
+                 << ": missing destination for " << url;
+      ++failed_;
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+CURL* BatchDownloader::acquireHandle() {
+  if (idleHandles_.empty()) return curl_easy_init();
+  CURL* curl = idleHandles_.back();
+  idleHandles_.pop_back();
+  return curl;
+}
+
+void BatchDownloader::releaseHandle(CURL* curl) {
+  // 连接缓存属于 multi 句柄，reset 不会断开已建立的连接
+  curl_easy_reset(curl);
+  idleHandles_.push_back(curl);
+}
+
+void BatchDownloader::startTransfer(std::unique_ptr<Transfer> transfer) {
+  CURL* curl = acquireHandle();
+  if (!curl) {
+    LOG(ERROR) << "[Batch] curl_easy_init failed for " << transfer->url;
+    ++failed_;
+    return;
+  }
+  transfer->curl = curl;
+  transfer->received = 0;
+  curl_easy_setopt(curl, CURLOPT_URL, transfer->url.c_str());
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+  SetCommonCurlOptions(curl);
+  curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_multi_add_handle(multi_, curl);
+  active_[curl] = std::move(transfer);
+}
+
+void BatchDownloader::finishTransfer(CURL* curl, CURLcode res) {
+  auto it = active_.find(curl);
+  std::unique_ptr<Transfer> transfer = std::move(it->second);
+  active_.erase(it);
+  curl_multi_remove_handle(multi_, curl);
+
+  long httpCode = 0;
+  curl_off_t retryAfter = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+  curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+  releaseHandle(curl);
+  transfer->curl = nullptr;
+
+  if (transfer->large) {
+    largeFiles_.emplace_back(std::move(transfer->url),
+                             std::move(transfer->dest));
+    return;
+  }
+
+  if (res == CURLE_OK) {
+    if (!transfer->ofs.is_open()) {
+      // 空文件不会触发写回调
+      transfer->ofs.open(transfer->tempPath(),
+                         std::ios::binary | std::ios::trunc);
+    }
+    transfer->ofs.close();
+    std::string tempPath = transfer->tempPath();
+    if (transfer->ofs &&
+        std::rename(tempPath.c_str(), transfer->dest.c_str()) == 0) {
+      ++succeeded_;
+      totalBytes_ += transfer->received;
+      LOG(DEBUG) << "[Batch] Done " << transfer->url << " -> "
+                 << transfer->dest << " (" << transfer->received << " bytes)";
+      return;
+    }
+    res = CURLE_WRITE_ERROR;
+  }
+
+  // 小文件失败后整体重下，不做续传
+  transfer->ofs.close();
+  transfer->ofs.clear();
+  if (retryPolicy_.isRetryable(res, httpCode) &&
+      transfer->attempt < retryPolicy_.maxRetries) {
+    ++transfer->attempt;
+    auto delay = retryPolicy_.nextDelay(transfer->attempt, retryAfter);
+    LOG(WARN) << "[Batch] " << transfer->url
+              << " failed: " << curl_easy_strerror(res) << " (http "
+              << httpCode << "), retrying in " << delay.count() << " ms";
+    delayed_.emplace(std::chrono::steady_clock::now() + delay,
+                     std::move(transfer));
+    return;
+  }
+
+  LOG(ERROR) << "[Batch] " << transfer->url
+             << " failed: " << curl_easy_strerror(res) << " (http "
+             << httpCode << ")";
+  // 只删除本次写入的临时文件，目标路径上已有的文件保持原样
+  std::remove(transfer->tempPath().c_str());
+  ++failed_;
+}
+
+long BatchDownloader::nextPollTimeoutMs() const {
+  if (delayed_.empty()) return kMaxPollTimeoutMs;
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      delayed_.begin()->first - std::chrono::steady_clock::now());
+  return std::clamp<long>(static_cast<long>(wait.count()), 0,
+                          kMaxPollTimeoutMs);
+}
+
+bool BatchDownloader::run(const std::string& listPath) {
+  std::ifstream list(listPath);
+  if (!list) {
+    LOG(ERROR) << "[Batch] Failed to open input list: " << listPath;
+    return false;
+  }
+  size_t concurrency =
+      static_cast<size_t>(std::max(1, FLAGS_batch_concurrency));
+  LOG(INFO) << "[Batch] Start " << listPath << ", concurrency "
+            << concurrency << ", small file threshold "
+            << FLAGS_small_file_threshold << " bytes";
+
+  auto begin = std::chrono::steady_clock::now();
+  bool listDone = false;
+  while (true) {
+    // 优先补充到期的重试，其次从列表读取新文件，保持 concurrency 个在途传输
+    while (active_.size() < concurrency) {
+      if (!delayed_.empty() &&
+          delayed_.begin()->first <= std::chrono::steady_clock::now()) {
+        auto node = delayed_.extract(delayed_.begin());
+        startTransfer(std::move(node.mapped()));
+        continue;
+      }
+      std::string url, dest;
+      if (listDone || !readEntry(list, url, dest)) {
+        listDone = true;
+        break;
+      }
+      auto transfer = std::make_unique<Transfer>();
+      transfer->url = std::move(url);
+      transfer->dest = std::move(dest);
+      transfer->threshold = FLAGS_small_file_threshold;
+      startTransfer(std::move(transfer));
+    }
+    if (active_.empty() && delayed_.empty() && listDone) break;
+
+    int running = 0;
+    curl_multi_perform(multi_, &running);
+    int queued = 0;
+    bool finishedAny = false;
+    while (CURLMsg* msg = curl_multi_info_read(multi_, &queued)) {
+      if (msg->msg == CURLMSG_DONE) {
+        finishedAny = true;
+        uint64_t before = succeeded_ + failed_;
+        finishTransfer(msg->easy_handle, msg->data.result);
+        uint64_t finished = succeeded_ + failed_;
+        if (finished != before && finished % kProgressEveryFiles == 0) {
+          LOG(INFO) << "[Batch] " << finished << " files finished, "
+                    << finished / std::max(secondsSince(begin), 1e-3)
+                    << " files/s";
+        }
+      }
+    }
+    // 有传输结束时立即回到循环开头补位，不在 poll 上等待空出的槽位
+    if (finishedAny) continue;
+    curl_multi_poll(multi_, nullptr, 0, static_cast<int>(nextPollTimeoutMs()),
+                    nullptr);
+  }
+
+  double smallSeconds = secondsSince(begin);
+  uint64_t smallFiles = succeeded_;
+  uint64_t smallBytes = totalBytes_;
+
+  // 大文件逐个走 HEAD + 分片下载
+  for (const auto& file : largeFiles_) {
+    createParentDirs(file.second);
+    if (downloader_.startDownload(file.first, file.second,
+                                  FLAGS_download_threads)) {
+      std::error_code ec;
+      auto size = std::filesystem::file_size(file.second, ec);
+      ++succeeded_;
+      totalBytes_ += ec ? 0 : size;
+    } else {
+      ++failed_;
+    }
+  }
+
+  double seconds = std::max(secondsSince(begin), 1e-3);
+  LOG(INFO) << "[Batch] Small files: " << smallFiles << " files, "
+            << smallBytes << " bytes in " << smallSeconds << " s";
+  LOG(INFO) << "[Batch] Finished: " << succeeded_ << " succeeded, " << failed_
+            << " failed (" << largeFiles_.size() << " split), " << totalBytes_
+            << " bytes in " << seconds << " s, " << succeeded_ / seconds
+            << " files/s, " << totalBytes_ / seconds / (1024 * 1024)
+            << " MiB/s";
+  return failed_ == 0;
+}
@@ -0,0 +1,75 @@
+#ifndef BATCH_DOWNLOADER_HPP_
+#define BATCH_DOWNLOADER_HPP_
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Downloader.hpp"
+#include "RetryPolicy.hpp"
+
+/**
+ * @brief 批量下载器：流式读取 "<url> <destination>" 列表，
+ *        小文件在一个 curl multi 句柄上并发传输（复用每个主机的长连接），
+ *        超过阈值的大文件交给 Downloader 分片下载
+ */
+class BatchDownloader {
+ public:
+  explicit BatchDownloader(Downloader& downloader);
+  ~BatchDownloader();
+
+  // 处理整个列表，全部文件成功时返回 true
+  bool run(const std::string& listPath);
+
+ private:
+  struct Transfer {
+    std::string url;
+    std::string dest;
+    std::ofstream ofs;  // 首次收到数据时才打开，大文件不会留下空文件
+    CURL* curl = nullptr;
+    int64_t threshold = 0;
+    uint64_t received = 0;
+    int attempt = 0;
+    bool large = false;  // Content-Length 超过阈值，已中止并转交分片下载
+
+    // 先写入临时文件，成功后再改名为 dest，失败不会破坏已有文件
+    std::string tempPath() const { return dest + ".tmp"; }
+  };
+
+  static size_t writeCallback(void* ptr, size_t size, size_t nmemb,
+                              void* userdata);
+
+  bool readEntry(std::ifstream& list, std::string& url, std::string& dest);
+  void startTransfer(std::unique_ptr<Transfer> transfer);
+  void finishTransfer(CURL* curl, CURLcode res);
+  long nextPollTimeoutMs() const;
+
+  CURL* acquireHandle();
+  void releaseHandle(CURL* curl);
+
+  Downloader& downloader_;
+  RetryPolicy retryPolicy_;
+  CURLM* multi_ = nullptr;
+
+  std::vector<CURL*> idleHandles_;  // 复用 easy 句柄，避免逐文件分配
+  std::unordered_map<CURL*, std::unique_ptr<Transfer>> active_;
+  std::multimap<std::chrono::steady_clock::time_point,
+                std::unique_ptr<Transfer>>
+      delayed_;  // 等待退避到期的重试
+  std::vector<std::pair<std::string, std::string>> largeFiles_;
+
+  uint64_t succeeded_ = 0;
+  uint64_t failed_ = 0;
+  uint64_t totalBytes_ = 0;
+  int lineNo_ = 0;
+};
+
+#endif  // BATCH_DOWNLOADER_HPP_
@@ -0,0 +1,24 @@
+#include "CurlCommon.hpp"
+
+namespace {
+
+constexpr long kConnectTimeoutMs = 15 * 1000;
+constexpr long kStallTimeoutSec = 30;  // 连续无数据超过该时长视为超时
+
+}  // namespace
+
+void SetCommonCurlOptions(CURL* curl) {
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, kConnectTimeoutMs);
+  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, kStallTimeoutSec);
+}
+
+bool RangeResponseOk(CURL* curl, bool acceptFullBody) {
+  if (acceptFullBody) return true;
+  long httpCode = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+  return httpCode == 206;
+}
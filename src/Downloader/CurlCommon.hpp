@@ -0,0 +1,14 @@
+#ifndef CURL_COMMON_HPP_
+#define CURL_COMMON_HPP_
+
+#include <curl/curl.h>
+
+// 各下载模式共用的传输选项：跟随重定向、HTTP 错误码视为失败、
+// 连接超时和停滞检测，保证不同模式的超时行为一致
+void SetCommonCurlOptions(CURL* curl);
+
+// Range 请求在写入前调用：服务端忽略 Range 返回 200 时继续写入会破坏数据，
+// 只有请求覆盖整个文件（acceptFullBody）时才允许非 206 响应
+bool RangeResponseOk(CURL* curl, bool acceptFullBody);
+
+#endif  // CURL_COMMON_HPP_
@@ -0,0 +1,33 @@
+#include "CurlTrace.hpp"
+
+#include <algorithm>
+
+#include "trace.hpp"
+
+void TraceCurlPhases(CURL* curl, uint64_t startUs, const std::string& args) {
+  if (!utils::Tracer::Enabled()) return;
+  curl_off_t dns = 0, connect = 0, tls = 0, ttfb = 0, total = 0;
+  curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+  curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+  curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+  curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb);
+  curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+  // 各时间点均为相对传输开始的累计微秒数，复用连接时前几段为 0
+  auto& tracer = utils::Tracer::GetInstance();
+  auto span = [&](const char* name, curl_off_t from, curl_off_t to) {
+    if (to > from) {
+      tracer.AddSpan(name, "curl", startUs + static_cast<uint64_t>(from),
+                     static_cast<uint64_t>(to - from), args);
+    }
+  };
+  connect = std::max(connect, dns);
+  tls = std::max(tls, connect);
+  ttfb = std::max(ttfb, tls);
+  total = std::max(total, ttfb);
+  span("dns", 0, dns);
+  span("connect", dns, connect);
+  span("tls", connect, tls);
+  span("ttfb", tls, ttfb);
+  span("transfer", ttfb, total);
+}
@@ -0,0 +1,13 @@
+#ifndef CURL_TRACE_HPP_
+#define CURL_TRACE_HPP_
+
+#include <curl/curl.h>
+
+#include <cstdint>
+#include <string>
+
+// 根据 curl 的计时信息把一次传输拆成 dns/connect/tls/ttfb/transfer 几段 span，
+// startUs 为 curl_easy_perform 开始时的 Tracer::NowUs()
+void TraceCurlPhases(CURL* curl, uint64_t startUs, const std::string& args);
+
+#endif  // CURL_TRACE_HPP_
@@ -0,0 +1,393 @@
+#include "DistCoordinator.hpp"
+
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+#include "Downloader.hpp"
+#include "logger.hpp"
+
+DECLARE_int64(lease_size);
+DECLARE_int32(lease_timeout_ms);
+DECLARE_int32(heartbeat_interval_ms);
+DECLARE_int32(dist_workers);
+DECLARE_int32(dist_idle_timeout_ms);
+DECLARE_string(trace_file);
+
+namespace {
+
+constexpr int kPollIntervalMs = 200;
+constexpr long kIdleWaitMs = 500;  // 暂无可分配区间时让工作进程稍后再来
+constexpr auto kShutdownGrace = std::chrono::seconds(10);
+constexpr auto kKillGrace = std::chrono::seconds(2);  // SIGTERM 后等待退出
+
+long msUntil(std::chrono::steady_clock::time_point t) {
+  return static_cast<long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          t - std::chrono::steady_clock::now())
+          .count());
+}
+
+}  // namespace
+
+DistCoordinator::DistCoordinator(const std::string& socketPath)
+    : socketPath_(socketPath), retryPolicy_(RetryPolicy::FromFlags()) {}
+
+DistCoordinator::~DistCoordinator() {
+  for (auto& kv : workers_) {
+    close(kv.first);
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+    unlink(socketPath_.c_str());
+  }
+  stopChildren();
+}
+
+void DistCoordinator::stopChildren() {
+  if (children_.empty()) return;
+  // 被 SIGSTOP 的进程收不到 SIGTERM，先 SIGCONT；超时仍未退出则 SIGKILL
+  for (pid_t pid : children_) {
+    kill(pid, SIGCONT);
+    kill(pid, SIGTERM);
+  }
+  auto deadline = std::chrono::steady_clock::now() + kKillGrace;
+  while (!children_.empty() && std::chrono::steady_clock::now() < deadline) {
+    reapChildren();
+    if (!children_.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+  for (pid_t pid : children_) {
+    LOG(WARN) << "[Dist] Worker pid " << pid << " did not exit, killing";
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+  children_.clear();
+}
+
+void DistCoordinator::spawnWorkers(int count) {
+  for (int i = 0; i < count; ++i) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      LOG(ERROR) << "[Dist] fork failed: " << std::strerror(errno);
+      return;
+    }
+    if (pid == 0) {
+      std::string socketArg = "--dist_socket=" + socketPath_;
+      std::string beatArg = "--heartbeat_interval_ms=" +
+                            std::to_string(FLAGS_heartbeat_interval_ms);
+      std::string traceArg = "--trace_file=" + FLAGS_trace_file;
+      execl("/proc/self/exe", "DownloaderApp", "--dist_role=worker",
+            socketArg.c_str(), beatArg.c_str(), traceArg.c_str(),
+            static_cast<char*>(nullptr));
+      _exit(127);
+    }
+    children_.insert(pid);
+    LOG(INFO) << "[Dist] Spawned worker pid " << pid;
+  }
+}
+
+void DistCoordinator::reapChildren() {
+  int status = 0;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    if (children_.erase(pid)) {
+      LOG(INFO) << "[Dist] Worker pid " << pid << " exited with status "
+                << (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+  }
+}
+
+void DistCoordinator::acceptWorker() {
+  int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd < 0) {
+    LOG(WARN) << "[Dist] accept failed: " << std::strerror(errno);
+    return;
+  }
+  workers_.emplace(fd, Worker(fd));
+}
+
+void DistCoordinator::dropWorker(int fd, const char* reason) {
+  auto it = workers_.find(fd);
+  if (it == workers_.end()) return;
+  LOG(WARN) << "[Dist] Worker pid " << it->second.pid << " " << reason;
+  for (size_t id = 0; id < leases_.size(); ++id) {
+    auto& lease = leases_[id];
+    if (lease.state == LeaseState::Leased && lease.owner == fd) {
+      lease.state = LeaseState::Pending;
+      lease.owner = -1;
+      lease.readyAt = std::chrono::steady_clock::now();
+      LOG(WARN) << "[Dist] Reassigning lease " << id << " from byte "
+                << lease.start + lease.done;
+    }
+  }
+  close(fd);
+  workers_.erase(it);
+}
+
+std::string DistCoordinator::grantLease(int fd) {
+  if (failed_ || completed_ == leases_.size()) return "DONE";
+  auto now = std::chrono::steady_clock::now();
+  long waitMs = kIdleWaitMs;
+  for (size_t id = 0; id < leases_.size(); ++id) {
+    auto& lease = leases_[id];
+    if (lease.state != LeaseState::Pending) continue;
+    if (lease.done > lease.end - lease.start) {
+      // 前一个持有者写完但未来得及上报 COMPLETE
+      lease.state = LeaseState::Done;
+      ++completed_;
+      continue;
+    }
+    if (lease.readyAt > now) {
+      waitMs = std::min(waitMs, msUntil(lease.readyAt));
+      continue;
+    }
+    lease.state = LeaseState::Leased;
+    lease.owner = fd;
+    lease.lastBeat = now;
+    lease.grantedDone = lease.done;
+    std::ostringstream oss;
+    oss << "RANGE " << id << " " << lease.start + lease.done << " "
+        << lease.end;
+    return oss.str();
+  }
+  if (completed_ == leases_.size()) return "DONE";
+  return "WAIT " + std::to_string(std::max(waitMs, 10L));
+}
+
+bool DistCoordinator::handleLine(int fd, const std::string& line) {
+  auto& worker = workers_.at(fd);
+  std::istringstream iss(line);
+  std::string cmd;
+  iss >> cmd;
+
+  if (cmd == "HELLO") {
+    iss >> worker.pid;
+    LOG(INFO) << "[Dist] Worker pid " << worker.pid << " connected";
+    return dist::SendLine(fd, "JOB " + std::to_string(fileSize_) + " " +
+                                  url_ + " " + tempPath_);
+  }
+  if (cmd == "LEASE") {
+    return dist::SendLine(fd, grantLease(fd));
+  }
+
+  size_t id = 0;
+  if (!(iss >> id) || id >= leases_.size()) {
+    LOG(WARN) << "[Dist] Bad message from pid " << worker.pid << ": " << line;
+    return false;
+  }
+  auto& lease = leases_[id];
+  // 租约已被回收时，旧持有者的心跳和失败上报一律忽略
+  bool owned = lease.state == LeaseState::Leased && lease.owner == fd;
+
+  if (cmd == "HEARTBEAT") {
+    uint64_t done = 0;
+    iss >> done;
+    if (owned) {
+      lease.lastBeat = std::chrono::steady_clock::now();
+      lease.done = std::max(lease.done, lease.grantedDone + done);
+    }
+  } else if (cmd == "COMPLETE") {
+    // 旧持有者写完的数据同样有效，直接接受
+    if (lease.state != LeaseState::Done) {
+      lease.state = LeaseState::Done;
+      lease.owner = -1;
+      lease.done = lease.end - lease.start + 1;
+      ++completed_;
+      LOG(INFO) << "[Dist] Lease " << id << " done by pid " << worker.pid
+                << " (" << completed_ << "/" << leases_.size() << ")";
+    }
+  } else if (cmd == "FAIL") {
+    uint64_t done = 0;
+    int code = 0;
+    long httpCode = 0;
+    long retryAfter = 0;
+    iss >> done >> code >> httpCode >> retryAfter;
+    if (owned) {
+      lease.done = std::max(lease.done, lease.grantedDone + done);
+      lease.owner = -1;
+      lease.state = LeaseState::Pending;
+      CURLcode res = static_cast<CURLcode>(code);
+      if (retryPolicy_.isRetryable(res, httpCode) &&
+          lease.attempt < retryPolicy_.maxRetries) {
+        ++lease.attempt;
+        auto delay = retryPolicy_.nextDelay(lease.attempt, retryAfter);
+        lease.readyAt = std::chrono::steady_clock::now() + delay;
+        LOG(WARN) << "[Dist] Lease " << id << " failed on pid " << worker.pid
+                  << ": " << curl_easy_strerror(res) << " (http " << httpCode
+                  << "), retrying in " << delay.count() << " ms";
+      } else {
+        failed_ = true;
+        LOG(ERROR) << "[Dist] Lease " << id << " failed on pid " << worker.pid
+                   << ": " << curl_easy_strerror(res) << " (http "
+                   << httpCode << ", attempt " << lease.attempt + 1 << ")";
+      }
+    }
+  } else {
+    LOG(WARN) << "[Dist] Unknown message from pid " << worker.pid << ": "
+              << line;
+    return false;
+  }
+  return true;
+}
+
+void DistCoordinator::expireLeases() {
+  auto now = std::chrono::steady_clock::now();
+  auto timeout = std::chrono::milliseconds(FLAGS_lease_timeout_ms);
+  for (size_t id = 0; id < leases_.size(); ++id) {
+    auto& lease = leases_[id];
+    if (lease.state == LeaseState::Leased && now - lease.lastBeat > timeout) {
+      LOG(WARN) << "[Dist] Lease " << id << " heartbeat timed out, "
+                << "reassigning from byte " << lease.start + lease.done;
+      lease.state = LeaseState::Pending;
+      lease.owner = -1;
+      lease.readyAt = now;
+    }
+  }
+}
+
+bool DistCoordinator::run(const std::string& url,
+                          const std::string& location) {
+  url_ = url;
+  location_ = location;
+  fileSize_ = Downloader::getRemoteFileSize(url);
+  if (fileSize_ == 0) {
+    LOG(ERROR) << "Failed to get remote file size!";
+    return false;
+  }
+
+  // 预分配临时文件，工作进程按偏移直接写入，全部完成后再改名为目标文件；
+  // 用绝对路径下发，单独启动的工作进程不必与协调者处于同一工作目录
+  std::error_code ec;
+  tempPath_ = std::filesystem::absolute(location + ".dist", ec).string();
+  if (ec) tempPath_ = location + ".dist";
+  int fd = open(tempPath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+  if (fd < 0 || ftruncate(fd, static_cast<off_t>(fileSize_)) != 0) {
+    LOG(ERROR) << "[Dist] Failed to preallocate " << tempPath_ << ": "
+               << std::strerror(errno);
+    if (fd >= 0) close(fd);
+    unlink(tempPath_.c_str());
+    return false;
+  }
+  close(fd);
+
+  uint64_t leaseSize =
+      static_cast<uint64_t>(std::max<int64_t>(FLAGS_lease_size, 1));
+  for (uint64_t start = 0; start < fileSize_; start += leaseSize) {
+    Lease lease;
+    lease.start = start;
+    lease.end = std::min(start + leaseSize, fileSize_) - 1;
+    leases_.push_back(lease);
+  }
+
+  listenFd_ = dist::ListenUnix(socketPath_);
+  if (listenFd_ < 0) {
+    unlink(tempPath_.c_str());
+    return false;
+  }
+  LOG(INFO) << "[Dist] Coordinator on " << socketPath_ << ": " << fileSize_
+            << " bytes in " << leases_.size() << " leases";
+
+  auto begin = std::chrono::steady_clock::now();
+  spawnWorkers(FLAGS_dist_workers);
+  bool spawned = !children_.empty();
+
+  std::chrono::steady_clock::time_point finishedAt{};
+  auto idleSince = begin;  // 最近一次没有任何工作进程的时刻
+  auto idleTimeout = std::chrono::milliseconds(FLAGS_dist_idle_timeout_ms);
+  while (true) {
+    auto now = std::chrono::steady_clock::now();
+    bool idle = workers_.empty() && children_.empty();
+    if (!idle) idleSince = now;
+    if (failed_ || completed_ == leases_.size()) {
+      // 等工作进程收到 DONE 后自行退出
+      if (workers_.empty() && children_.empty()) break;
+      if (finishedAt == std::chrono::steady_clock::time_point{}) {
+        finishedAt = now;
+      }
+      if (now - finishedAt > kShutdownGrace) break;
+    } else if (spawned && idle) {
+      LOG(ERROR) << "[Dist] All workers exited before the download finished";
+      failed_ = true;
+      continue;
+    } else if (idle && now - idleSince > idleTimeout) {
+      LOG(ERROR) << "[Dist] No worker connected for "
+                 << FLAGS_dist_idle_timeout_ms << " ms, giving up";
+      failed_ = true;
+      continue;
+    }
+
+    std::vector<pollfd> fds;
+    fds.push_back({listenFd_, POLLIN, 0});
+    for (auto& kv : workers_) {
+      fds.push_back({kv.first, POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), kPollIntervalMs) < 0 && errno != EINTR) {
+      LOG(ERROR) << "[Dist] poll failed: " << std::strerror(errno);
+      failed_ = true;
+      break;
+    }
+    for (size_t i = 1; i < fds.size(); ++i) {
+      if (!fds[i].revents) continue;
+      int workerFd = fds[i].fd;
+      auto& reader = workers_.at(workerFd).reader;
+      if (!reader.Fill()) {
+        dropWorker(workerFd, "disconnected");
+        continue;
+      }
+      std::string line;
+      while (reader.NextLine(line)) {
+        if (!handleLine(workerFd, line)) {
+          dropWorker(workerFd, "dropped");
+          break;
+        }
+      }
+    }
+    if (fds[0].revents & POLLIN) acceptWorker();
+    expireLeases();
+    reapChildren();
+  }
+
+  // 先结束自己拉起的工作进程，确保改名后不会再有写入
+  stopChildren();
+
+  double seconds = std::max(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+          .count(),
+      1e-3);
+  bool ok = !failed_ && completed_ == leases_.size();
+  if (ok) {
+    fd = open(tempPath_.c_str(), O_WRONLY | O_CLOEXEC);
+    ok = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    if (ok && rename(tempPath_.c_str(), location.c_str()) != 0) {
+      LOG(ERROR) << "[Dist] Failed to rename " << tempPath_ << " to "
+                 << location << ": " << std::strerror(errno);
+      ok = false;
+    }
+  }
+  if (!ok) {
+    unlink(tempPath_.c_str());
+    LOG(ERROR) << "[Dist] Download failed: " << completed_ << "/"
+               << leases_.size() << " leases completed, output not written";
+    return false;
+  }
+  LOG(INFO) << "[Dist] All leases done, " << fileSize_ << " bytes written to "
+            << location << " in " << seconds << " s ("
+            << fileSize_ / seconds / (1024 * 1024) << " MiB/s)";
+  return true;
+}
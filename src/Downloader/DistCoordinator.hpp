@@ -0,0 +1,76 @@
+#ifndef DIST_COORDINATOR_HPP_
+#define DIST_COORDINATOR_HPP_
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "DistProtocol.hpp"
+#include "RetryPolicy.hpp"
+
+/**
+ * @brief 分布式下载协调者：预分配目标文件，把文件切成租约区间，
+ *        通过本地 socket 分发给工作进程；工作进程直接写入目标文件，
+ *        心跳超时或断开连接的租约会被回收并重新分配
+ */
+class DistCoordinator {
+ public:
+  explicit DistCoordinator(const std::string& socketPath);
+  ~DistCoordinator();
+
+  // 下载完成且所有区间写入成功时返回 true
+  bool run(const std::string& url, const std::string& location);
+
+ private:
+  enum class LeaseState { Pending, Leased, Done };
+
+  struct Lease {
+    uint64_t start;
+    uint64_t end;              // 闭区间
+    uint64_t done = 0;         // 从 start 起已写入的字节数
+    uint64_t grantedDone = 0;  // 授予时的 done，工作进程上报的进度以此为基准
+    int attempt = 0;
+    int owner = -1;  // 持有租约的工作进程连接
+    LeaseState state = LeaseState::Pending;
+    std::chrono::steady_clock::time_point lastBeat;
+    std::chrono::steady_clock::time_point readyAt;  // 退避到期时间
+  };
+
+  struct Worker {
+    explicit Worker(int fd) : reader(fd) {}
+    dist::LineReader reader;
+    pid_t pid = 0;
+  };
+
+  void spawnWorkers(int count);
+  void reapChildren();
+  void stopChildren();
+  void acceptWorker();
+  void dropWorker(int fd, const char* reason);
+  bool handleLine(int fd, const std::string& line);
+  std::string grantLease(int fd);
+  void expireLeases();
+
+  std::string socketPath_;
+  RetryPolicy retryPolicy_;
+  int listenFd_ = -1;
+
+  std::string url_;
+  std::string location_;
+  std::string tempPath_;  // 下载期间写入的临时文件，成功后改名为 location_
+  uint64_t fileSize_ = 0;
+
+  std::vector<Lease> leases_;
+  size_t completed_ = 0;
+  bool failed_ = false;
+
+  std::map<int, Worker> workers_;
+  std::set<pid_t> children_;
+};
+
+#endif  // DIST_COORDINATOR_HPP_
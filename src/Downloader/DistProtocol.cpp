@@ -0,0 +1,103 @@
+#include "DistProtocol.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger.hpp"
+
+namespace dist {
+
+namespace {
+
+bool fillAddress(const std::string& path, sockaddr_un& addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    LOG(ERROR) << "[Dist] Invalid socket path: " << path;
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+}  // namespace
+
+int ListenUnix(const std::string& path) {
+  sockaddr_un addr;
+  if (!fillAddress(path, addr)) return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    LOG(ERROR) << "[Dist] socket failed: " << std::strerror(errno);
+    return -1;
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    LOG(ERROR) << "[Dist] Failed to listen on " << path << ": "
+               << std::strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int ConnectUnix(const std::string& path) {
+  sockaddr_un addr;
+  if (!fillAddress(path, addr)) return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    LOG(ERROR) << "[Dist] socket failed: " << std::strerror(errno);
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    LOG(ERROR) << "[Dist] Failed to connect to " << path << ": "
+               << std::strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool SendLine(int fd, const std::string& line) {
+  std::string msg = line + "\n";
+  size_t sent = 0;
+  while (sent < msg.size()) {
+    ssize_t n = send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool LineReader::Fill() {
+  char buf[4096];
+  while (true) {
+    ssize_t n = read(fd_, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    buf_.append(buf, static_cast<size_t>(n));
+    return true;
+  }
+}
+
+bool LineReader::NextLine(std::string& line) {
+  auto pos = buf_.find('\n');
+  if (pos == std::string::npos) return false;
+  line = buf_.substr(0, pos);
+  buf_.erase(0, pos + 1);
+  return true;
+}
+
+bool LineReader::ReadLine(std::string& line) {
+  while (!NextLine(line)) {
+    if (!Fill()) return false;
+  }
+  return true;
+}
+
+}  // namespace dist
@@ -0,0 +1,51 @@
+#ifndef DIST_PROTOCOL_HPP_
+#define DIST_PROTOCOL_HPP_
+
+#include <string>
+
+/**
+ * @brief 分布式下载的协调者/工作进程行协议，每条消息以 '\n' 结尾
+ *
+ * worker -> coordinator:
+ *   HELLO <pid>
+ *   LEASE
+ *   HEARTBEAT <id> <done>
+ *   COMPLETE <id>
+ *   FAIL <id> <done> <curlcode> <httpcode> <retry_after_sec>
+ * coordinator -> worker（只在收到 HELLO / LEASE 时回复）:
+ *   JOB <file_size> <url> <location>
+ *   RANGE <id> <start> <end>
+ *   WAIT <ms>
+ *   DONE
+ *
+ * <done> 为从本次 RANGE 的 <start> 起已写入的字节数，协调者加上授予时的
+ * 进度得到区间总进度，租约被回收后从此处续传。<location> 是协调者预分配的
+ * 临时文件，全部区间完成后由协调者改名为最终目标。
+ */
+namespace dist {
+
+int ListenUnix(const std::string& path);
+int ConnectUnix(const std::string& path);
+
+// 整行写出，对端关闭时返回 false（不触发 SIGPIPE）
+bool SendLine(int fd, const std::string& line);
+
+class LineReader {
+ public:
+  explicit LineReader(int fd) : fd_(fd) {}
+
+  // 读取一次 socket 数据追加到缓冲区，EOF 或出错时返回 false
+  bool Fill();
+  // 从缓冲区取出一整行（不含 '\n'）
+  bool NextLine(std::string& line);
+  // 阻塞直到读到一整行
+  bool ReadLine(std::string& line);
+
+ private:
+  int fd_;
+  std::string buf_;
+};
+
+}  // namespace dist
+
+#endif  // DIST_PROTOCOL_HPP_
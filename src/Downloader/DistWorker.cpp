@@ -0,0 +1,169 @@
+#include "DistWorker.hpp"
+
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include "CurlCommon.hpp"
+#include "CurlTrace.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+
+DECLARE_int32(heartbeat_interval_ms);
+
+DistWorker::DistWorker(const std::string& socketPath)
+    : socketPath_(socketPath) {}
+
+DistWorker::~DistWorker() {
+  heartbeatTimer_.stop();
+  if (fileFd_ >= 0) close(fileFd_);
+  if (sockFd_ >= 0) close(sockFd_);
+}
+
+size_t DistWorker::writeCallback(void* ptr, size_t size, size_t nmemb,
+                                 void* userdata) {
+  RangeSink* sink = static_cast<RangeSink*>(userdata);
+  if (!RangeResponseOk(sink->curl, sink->acceptFullBody)) return 0;
+  const char* data = static_cast<const char*>(ptr);
+  size_t total = size * nmemb;
+  size_t written = 0;
+  while (written < total) {
+    uint64_t done = sink->done->load(std::memory_order_relaxed);
+    uint64_t beginUs = sink->writes->Begin();
+    ssize_t n = pwrite(sink->fd, data + written, total - written,
+                       static_cast<off_t>(sink->offset + done));
+    sink->writes->End(beginUs, n > 0 ? static_cast<uint64_t>(n) : 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return 0;
+    written += static_cast<size_t>(n);
+    sink->done->fetch_add(static_cast<uint64_t>(n),
+                          std::memory_order_relaxed);
+  }
+  return total;
+}
+
+bool DistWorker::send(const std::string& line) {
+  std::lock_guard<std::mutex> lock(sendMutex_);
+  return dist::SendLine(sockFd_, line);
+}
+
+void DistWorker::sendHeartbeat() {
+  int64_t id = leaseId_.load();
+  if (id < 0) return;
+  send("HEARTBEAT " + std::to_string(id) + " " +
+       std::to_string(leaseDone_.load()));
+}
+
+bool DistWorker::fetchRange(uint64_t id, uint64_t start, uint64_t end) {
+  // 协调者给出的 start 已包含此前写入的进度，上报的 done 从 start 起计，
+  // 由协调者换算成区间总进度
+  leaseDone_ = 0;
+  leaseId_ = static_cast<int64_t>(id);
+  std::string traceArgs = utils::Tracer::Enabled()
+                              ? "\"lease\":" + std::to_string(id)
+                              : std::string();
+  TRACE_SCOPE("lease", "download", traceArgs);
+
+  CURLcode res = CURLE_FAILED_INIT;
+  long httpCode = 0;
+  curl_off_t retryAfter = 0;
+  CURL* curl = curl_easy_init();
+  if (curl) {
+    utils::SpanAccumulator writes("write", "io");
+    RangeSink sink{fileFd_, start, &leaseDone_, curl,
+                   start == 0 && end == fileSize_ - 1, &writes};
+    std::string range = std::to_string(start) + "-" + std::to_string(end);
+    curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    SetCommonCurlOptions(curl);
+
+    LOG(INFO) << "[Dist] Worker downloading lease " << id << " [" << range
+              << "]";
+    uint64_t performUs = utils::Tracer::GetInstance().NowUs();
+    res = curl_easy_perform(curl);
+    TraceCurlPhases(curl, performUs, traceArgs);
+    writes.Record(traceArgs);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+    curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+    curl_easy_cleanup(curl);
+  }
+
+  uint64_t done = leaseDone_.load();
+  leaseId_ = -1;
+  if (res == CURLE_OK && done != end - start + 1) {
+    res = CURLE_PARTIAL_FILE;
+  }
+  if (res == CURLE_OK) {
+    return send("COMPLETE " + std::to_string(id));
+  }
+  LOG(WARN) << "[Dist] Worker lease " << id
+            << " failed: " << curl_easy_strerror(res) << " (http " << httpCode
+            << "), " << done << " bytes written";
+  std::ostringstream oss;
+  oss << "FAIL " << id << " " << done << " " << static_cast<int>(res) << " "
+      << httpCode << " " << retryAfter;
+  return send(oss.str());
+}
+
+bool DistWorker::run() {
+  sockFd_ = dist::ConnectUnix(socketPath_);
+  if (sockFd_ < 0) return false;
+  dist::LineReader reader(sockFd_);
+
+  std::string line;
+  if (!send("HELLO " + std::to_string(getpid())) || !reader.ReadLine(line)) {
+    LOG(ERROR) << "[Dist] Handshake with coordinator failed";
+    return false;
+  }
+  std::istringstream job(line);
+  std::string cmd, location;
+  job >> cmd >> fileSize_ >> url_ >> std::ws;
+  std::getline(job, location);
+  if (cmd != "JOB" || fileSize_ == 0 || location.empty()) {
+    LOG(ERROR) << "[Dist] Unexpected handshake reply: " << line;
+    return false;
+  }
+  // 目标文件由协调者预分配，这里不截断
+  fileFd_ = open(location.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fileFd_ < 0) {
+    LOG(ERROR) << "[Dist] Failed to open " << location << ": "
+               << std::strerror(errno);
+    return false;
+  }
+
+  heartbeatTimer_.addPeriodicTask(
+      std::chrono::milliseconds(FLAGS_heartbeat_interval_ms),
+      std::chrono::milliseconds(FLAGS_heartbeat_interval_ms),
+      [this]() { sendHeartbeat(); });
+  heartbeatTimer_.start();
+
+  while (send("LEASE") && reader.ReadLine(line)) {
+    std::istringstream iss(line);
+    iss >> cmd;
+    if (cmd == "DONE") {
+      LOG(INFO) << "[Dist] Worker " << getpid() << " finished";
+      return true;
+    }
+    if (cmd == "WAIT") {
+      long ms = 0;
+      iss >> ms;
+      std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+      continue;
+    }
+    uint64_t id = 0, start = 0, end = 0;
+    if (cmd != "RANGE" || !(iss >> id >> start >> end)) {
+      LOG(ERROR) << "[Dist] Unexpected reply: " << line;
+      return false;
+    }
+    if (!fetchRange(id, start, end)) break;
+  }
+  LOG(ERROR) << "[Dist] Lost connection to coordinator";
+  return false;
+}
@@ -0,0 +1,56 @@
+#ifndef DIST_WORKER_HPP_
+#define DIST_WORKER_HPP_
+
+#include <curl/curl.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "DistProtocol.hpp"
+#include "timer.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief 分布式下载工作进程：向协调者申请区间，下载后直接写入共享的
+ *        目标文件，并通过 utils::Timer 周期上报心跳和进度
+ */
+class DistWorker {
+ public:
+  explicit DistWorker(const std::string& socketPath);
+  ~DistWorker();
+
+  // 协调者下发 DONE 时返回 true，连接异常断开时返回 false
+  bool run();
+
+ private:
+  struct RangeSink {
+    int fd;
+    uint64_t offset;
+    std::atomic<uint64_t>* done;
+    CURL* curl;
+    bool acceptFullBody;
+    utils::SpanAccumulator* writes;  // 整个租约的写入汇总为一个 span
+  };
+
+  static size_t writeCallback(void* ptr, size_t size, size_t nmemb,
+                              void* userdata);
+
+  bool send(const std::string& line);
+  void sendHeartbeat();
+  bool fetchRange(uint64_t id, uint64_t start, uint64_t end);
+
+  std::string socketPath_;
+  int sockFd_ = -1;
+  int fileFd_ = -1;
+  std::string url_;
+  uint64_t fileSize_ = 0;
+
+  std::mutex sendMutex_;  // 心跳在定时器线程发送，与主线程共用连接
+  std::atomic<int64_t> leaseId_{-1};
+  std::atomic<uint64_t> leaseDone_{0};
+  utils::Timer heartbeatTimer_;
+};
+
+#endif  // DIST_WORKER_HPP_
@@ -2,6 +2,8 @@
 
 #include <curl/curl.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
@@ -10,21 +12,66 @@
 #include <thread>
 #include <vector>
 
+#include "CurlCommon.hpp"
+#include "CurlTrace.hpp"
+#include "FileMerger.hpp"
 #include "logger.hpp"
 #include "tbb_manager.hpp"
 #include "timer.hpp"
+#include "trace.hpp"
 
 namespace {
 
+// 分片边界按该粒度对齐，合并时 FICLONERANGE 才能按块共享数据
+constexpr size_t kChunkAlign = 64 * 1024;
+
+// 单个分片的写入目标
+struct ChunkSink {
+  std::ofstream* ofs;
+  size_t* received;
+  CURL* curl;
+  bool acceptFullBody;  // 请求覆盖整个文件时允许服务端返回 200
+  utils::SpanAccumulator* writes;  // 整个分片的写入汇总为一个 span
+};
+
 // 写入回调
 size_t write_data(void* ptr, size_t size, size_t nmemb, void* stream) {
-  std::ofstream* ofs = static_cast<std::ofstream*>(stream);
-  ofs->write(static_cast<char*>(ptr), size * nmemb);
+  ChunkSink* sink = static_cast<ChunkSink*>(stream);
+  if (!RangeResponseOk(sink->curl, sink->acceptFullBody)) return 0;
+  uint64_t beginUs = sink->writes->Begin();
+  sink->ofs->write(static_cast<char*>(ptr), size * nmemb);
+  sink->writes->End(beginUs, size * nmemb);
+  if (!*sink->ofs) return 0;
+  *sink->received += size * nmemb;
   return size * nmemb;
 }
 
+}  // namespace
+
+struct Downloader::DownloadState {
+  struct Chunk {
+    size_t start;
+    size_t end;
+    size_t received = 0;  // 已落盘字节数，重试时从此处续传
+    int attempt = 0;
+    std::string partFile;
+  };
+
+  std::string url;
+  size_t fileSize = 0;
+  std::vector<Chunk> chunks;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  int pending = 0;      // 尚未到达终态的分片数
+  bool failed = false;  // 任一分片最终失败
+};
+
+Downloader::Downloader() : retryPolicy_(RetryPolicy::FromFlags()) {}
+Downloader::~Downloader() {}
+
 // 获取远程文件大小
-size_t getRemoteFileSize(const std::string& url) {
+size_t Downloader::getRemoteFileSize(const std::string& url) {
   CURL* curl = curl_easy_init();
   double file_size = 0;
   if (curl) {
@@ -40,12 +87,118 @@ size_t getRemoteFileSize(const std::string& url) {
   return static_cast<size_t>(file_size);
 }
 
-}  // namespace
+void Downloader::runChunk(const std::shared_ptr<DownloadState>& state,
+                          int idx) {
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->failed) {
+      // 其他分片已经失败，无需继续消耗带宽
+      if (--state->pending == 0) state->cv.notify_all();
+      return;
+    }
+  }
 
-Downloader::Downloader() {}
-Downloader::~Downloader() {}
+  const auto& chunk = state->chunks[idx];
+  std::string traceArgs =
+      utils::Tracer::Enabled()
+          ? "\"chunk\":" + std::to_string(idx) +
+                ",\"attempt\":" + std::to_string(chunk.attempt)
+          : std::string();
+  ChunkResult result;
+  std::chrono::milliseconds retryDelay(0);
+  {
+    // span 须在 pending 递减或重新投递前结束：之后主线程可能立即 Flush
+    TRACE_SCOPE("chunk", "download", traceArgs);
+    result = fetchChunk(state, idx, traceArgs, &retryDelay);
+  }
+  if (result == ChunkResult::Retrying) {
+    // 退避等待交给定时器线程，到期后再投递回 download arena
+    retryTimer_.addOnceTask(retryDelay, [this, state, idx]() {
+      utils::TBBManager::GetInstance().Enqueue(
+          "download", [this, state, idx]() { runChunk(state, idx); });
+    });
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (result == ChunkResult::Failed) state->failed = true;
+  if (--state->pending == 0) state->cv.notify_all();
+}
 
-void Downloader::startDownload(const std::string& url,
+Downloader::ChunkResult Downloader::fetchChunk(
+    const std::shared_ptr<DownloadState>& state, int idx,
+    const std::string& traceArgs, std::chrono::milliseconds* retryDelay) {
+  auto& chunk = state->chunks[idx];
+  CURL* curl = curl_easy_init();
+  if (!curl) {
+    LOG(ERROR) << "curl_easy_init failed for chunk " << idx;
+    return ChunkResult::Failed;
+  }
+
+  // 首次尝试截断分片文件，重试时追加
+  std::ofstream ofs(chunk.partFile,
+                    std::ios::binary | (chunk.attempt == 0 ? std::ios::trunc
+                                                           : std::ios::app));
+  if (!ofs) {
+    LOG(ERROR) << "Failed to open part file: " << chunk.partFile;
+    curl_easy_cleanup(curl);
+    return ChunkResult::Failed;
+  }
+
+  size_t offset = chunk.start + chunk.received;
+  utils::SpanAccumulator writes("write", "io");
+  ChunkSink sink{&ofs, &chunk.received, curl,
+                 offset == 0 && chunk.end == state->fileSize - 1, &writes};
+  std::string range = std::to_string(offset) + "-" + std::to_string(chunk.end);
+  curl_easy_setopt(curl, CURLOPT_URL, state->url.c_str());
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+  curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+  SetCommonCurlOptions(curl);
+
+  LOG(INFO) << "Downloading chunk " << idx << " [" << range << "]"
+            << (chunk.attempt > 0
+                    ? " (retry " + std::to_string(chunk.attempt) + ")"
+                    : "");
+  uint64_t performUs = utils::Tracer::GetInstance().NowUs();
+  CURLcode res = curl_easy_perform(curl);
+  TraceCurlPhases(curl, performUs, traceArgs);
+  writes.Record(traceArgs);
+  long httpCode = 0;
+  curl_off_t retryAfter = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+  curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retryAfter);
+  curl_easy_cleanup(curl);
+  ofs.close();
+
+  size_t expected = chunk.end - chunk.start + 1;
+  if (res == CURLE_OK && chunk.received != expected) {
+    // 连接提前关闭但 curl 未报错，按不完整传输处理
+    res = CURLE_PARTIAL_FILE;
+  }
+  if (res == CURLE_OK) {
+    LOG(INFO) << "Chunk " << idx << " done.";
+    return ChunkResult::Done;
+  }
+
+  if (!retryPolicy_.isRetryable(res, httpCode) ||
+      chunk.attempt >= retryPolicy_.maxRetries) {
+    LOG(ERROR) << "Chunk " << idx << " failed: " << curl_easy_strerror(res)
+               << " (http " << httpCode << ", attempt " << chunk.attempt + 1
+               << ")";
+    return ChunkResult::Failed;
+  }
+
+  ++chunk.attempt;
+  *retryDelay = retryPolicy_.nextDelay(chunk.attempt, retryAfter);
+  LOG(WARN) << "Chunk " << idx << " failed: " << curl_easy_strerror(res)
+            << " (http " << httpCode << "), " << chunk.received << "/"
+            << expected << " bytes received, retrying in "
+            << retryDelay->count() << " ms";
+  return ChunkResult::Retrying;
+}
+
+bool Downloader::startDownload(const std::string& url,
                                const std::string& location, int threadCount) {
   LOG(INFO) << "Starting download from " << url << " to " << location
             << " with "
@@ -57,71 +210,65 @@ void Downloader::startDownload(const std::string& url,
   size_t fileSize = getRemoteFileSize(url);
   if (fileSize == 0) {
     LOG(ERROR) << "Failed to get remote file size!";
-    return;
+    return false;
   }
   LOG(INFO) << "Remote file size: " << fileSize;
 
   // 分片
   int totalChunks =
       threadCount > 0 ? threadCount : tbb::info::default_concurrency();
+  totalChunks = static_cast<int>(
+      std::min<size_t>(static_cast<size_t>(totalChunks), fileSize));
   size_t chunkSize = fileSize / totalChunks;
-  std::vector<std::string> tempFiles(totalChunks);
+  if (chunkSize > kChunkAlign) chunkSize -= chunkSize % kChunkAlign;
 
-  // 多线程分片下载
+  auto state = std::make_shared<DownloadState>();
+  state->url = url;
+  state->fileSize = fileSize;
+  state->pending = totalChunks;
+  state->chunks.resize(totalChunks);
+  for (int idx = 0; idx < totalChunks; ++idx) {
+    auto& chunk = state->chunks[idx];
+    chunk.start = idx * chunkSize;
+    chunk.end = (idx == totalChunks - 1) ? (fileSize - 1)
+                                         : (chunk.start + chunkSize - 1);
+    std::ostringstream oss;
+    oss << location << ".part" << idx;
+    chunk.partFile = oss.str();
+  }
+
+  // 多线程分片下载，失败的分片由定时器按退避时间重新投递
+  retryTimer_.start();
   utils::TBBManager::GetInstance().ParallelFor<int>(
-      "download", 0, totalChunks, [&](int idx) {
-        size_t start = idx * chunkSize;
-        size_t end =
-            (idx == totalChunks - 1) ? (fileSize - 1) : (start + chunkSize - 1);
-
-        std::ostringstream oss;
-        oss << location << ".part" << idx;
-        std::string partFile = oss.str();
-        tempFiles[idx] = partFile;
-
-        CURL* curl = curl_easy_init();
-        if (!curl) {
-          LOG(ERROR) << "curl_easy_init failed for chunk " << idx;
-          return;
-        }
-        std::ofstream ofs(partFile, std::ios::binary);
-        if (!ofs) {
-          LOG(ERROR) << "Failed to open part file: " << partFile;
-          curl_easy_cleanup(curl);
-          return;
-        }
-        std::string range = std::to_string(start) + "-" + std::to_string(end);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ofs);
-        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-
-        LOG(INFO) << "Downloading chunk " << idx << " [" << range << "]";
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-          LOG(ERROR) << "Chunk " << idx
-                     << " failed: " << curl_easy_strerror(res);
-        } else {
-          LOG(INFO) << "Chunk " << idx << " done.";
-        }
-        curl_easy_cleanup(curl);
-        ofs.close();
-      });
+      "download", 0, totalChunks, [&](int idx) { runChunk(state, idx); });
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state]() { return state->pending == 0; });
+  }
+
+  if (state->failed) {
+    for (const auto& chunk : state->chunks) {
+      std::remove(chunk.partFile.c_str());
+    }
+    LOG(ERROR) << "Download failed, output not written: " << location;
+    return false;
+  }
 
   // 合并分片
-  std::ofstream ofs(location, std::ios::binary);
-  if (!ofs) {
-    LOG(ERROR) << "Failed to create output file: " << location;
-    return;
+  std::vector<MergePart> parts;
+  parts.reserve(state->chunks.size());
+  for (const auto& chunk : state->chunks) {
+    parts.push_back({chunk.partFile, chunk.start, chunk.end - chunk.start + 1});
   }
-  for (const auto& partFile : tempFiles) {
-    std::ifstream ifs(partFile, std::ios::binary);
-    ofs << ifs.rdbuf();
-    ifs.close();
-    std::remove(partFile.c_str());
+  bool merged = FileMerger::Merge(location, parts);
+  for (const auto& chunk : state->chunks) {
+    std::remove(chunk.partFile.c_str());
+  }
+  if (!merged) {
+    LOG(ERROR) << "Failed to merge chunks into " << location;
+    return false;
   }
-  ofs.close();
 
   LOG(INFO) << "All chunks downloaded and merged to " << location;
-}
\ No newline at end of file
+  return true;
+}
@@ -1,23 +1,30 @@
 #ifndef DOWNLOADER_HPP_
 #define DOWNLOADER_HPP_
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 
+#include "RetryPolicy.hpp"
 #include "logger.hpp"
+#include "timer.hpp"
 
 class Downloader {
  public:
   Downloader();
   ~Downloader();
 
-  void startDownload(const std::string& user, const std::string& location,
+  // 分片下载并合并，全部分片成功时返回 true
+  bool startDownload(const std::string& user, const std::string& location,
                      int threadCount = 0);
   void cancelDownload(int taskId);
   void listDownloads() const;
 
+  // HEAD 请求获取远程文件大小，失败时返回 0
+  static size_t getRemoteFileSize(const std::string& url);
+
  private:
   struct DownloadTask {
     int id;
@@ -28,12 +35,25 @@ class Downloader {
     // Additional fields for progress tracking, etc.
   };
 
+  // 单次下载中所有分片共享的状态（见 Downloader.cpp）
+  struct DownloadState;
+
+  // 分片单次尝试的结果，Retrying 时由调用方按退避时间重新投递
+  enum class ChunkResult { Done, Failed, Retrying };
+
   int nextTaskId_;
   std::unordered_map<int, DownloadTask> tasks_;
   std::shared_ptr<utils::Logger> logger_;
 
+  RetryPolicy retryPolicy_;
+  utils::Timer retryTimer_;  // 退避等待在定时器线程上完成，不占用TBB线程
+
   void reportProgress(int taskId, size_t downloaded, size_t total);
   void handleDownload(const DownloadTask& task);
+  void runChunk(const std::shared_ptr<DownloadState>& state, int idx);
+  ChunkResult fetchChunk(const std::shared_ptr<DownloadState>& state, int idx,
+                         const std::string& traceArgs,
+                         std::chrono::milliseconds* retryDelay);
 };
 
-#endif  // DOWNLOADER_HPP_
\ No newline at end of file
+#endif  // DOWNLOADER_HPP_
@@ -0,0 +1,197 @@
+#include "FileMerger.hpp"
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "logger.hpp"
+#include "tbb_manager.hpp"
+#include "trace.hpp"
+
+namespace {
+
+constexpr size_t kCopyBufferSize = 1 << 20;
+
+bool cloneRange(int srcFd, int destFd, const MergePart& part) {
+  file_clone_range range;
+  range.src_fd = srcFd;
+  range.src_offset = 0;
+  range.src_length = part.length;
+  range.dest_offset = part.offset;
+  return ioctl(destFd, FICLONERANGE, &range) == 0;
+}
+
+// 返回 false 且 errno 为 EXDEV/ENOSYS/EOPNOTSUPP/EINVAL 时表示不支持，可回退
+bool copyRange(int srcFd, int destFd, const MergePart& part) {
+  loff_t inOff = 0;
+  loff_t outOff = static_cast<loff_t>(part.offset);
+  uint64_t left = part.length;
+  while (left > 0) {
+    ssize_t n = copy_file_range(srcFd, &inOff, destFd, &outOff, left, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      if (n == 0) errno = EIO;  // 分片比预期短
+      return false;
+    }
+    left -= static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+bool readWriteRange(int srcFd, int destFd, const MergePart& part) {
+  std::vector<char> buf(kCopyBufferSize);
+  uint64_t done = 0;
+  while (done < part.length) {
+    size_t want = static_cast<size_t>(
+        std::min<uint64_t>(buf.size(), part.length - done));
+    ssize_t n = pread(srcFd, buf.data(), want, static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      if (n == 0) errno = EIO;
+      return false;
+    }
+    size_t written = 0;
+    while (written < static_cast<size_t>(n)) {
+      ssize_t w = pwrite(destFd, buf.data() + written, n - written,
+                         static_cast<off_t>(part.offset + done + written));
+      if (w < 0 && errno == EINTR) continue;
+      if (w <= 0) return false;
+      written += static_cast<size_t>(w);
+    }
+    done += static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+bool unsupported(int err) {
+  return err == EXDEV || err == ENOSYS || err == EOPNOTSUPP ||
+         err == EINVAL || err == ENOTTY;
+}
+
+}  // namespace
+
+const char* MergeMethodName(MergeMethod method) {
+  switch (method) {
+    case MergeMethod::Reflink:
+      return "reflink";
+    case MergeMethod::CopyFileRange:
+      return "copy_file_range";
+    case MergeMethod::ReadWrite:
+      return "read/write";
+    default:
+      return "unknown";
+  }
+}
+
+bool FileMerger::Merge(const std::string& dest,
+                       const std::vector<MergePart>& parts,
+                       MergeMethod preferred) {
+  TRACE_SCOPE("merge", "io");
+  auto begin = std::chrono::steady_clock::now();
+
+  uint64_t total = 0;
+  for (const auto& part : parts) {
+    total = std::max(total, part.offset + part.length);
+  }
+  // 先合并到同目录的临时文件，成功后再改名，失败时不留下带空洞的目标文件
+  std::string tempPath = dest + ".merge";
+  int destFd = open(tempPath.c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (destFd < 0 || ftruncate(destFd, static_cast<off_t>(total)) != 0) {
+    LOG(ERROR) << "Failed to create output file: " << tempPath << ": "
+               << std::strerror(errno);
+    if (destFd >= 0) {
+      close(destFd);
+      unlink(tempPath.c_str());
+    }
+    return false;
+  }
+
+  // 一旦某种方式在该文件系统上不可用，后续分片直接从下一级开始
+  std::atomic<int> floor{static_cast<int>(preferred)};
+  std::atomic<int> used[3] = {{0}, {0}, {0}};
+  std::atomic<bool> ok{true};
+
+  utils::TBBManager::GetInstance().ParallelFor<int>(
+      "merge", 0, static_cast<int>(parts.size()), [&](int idx) {
+        const auto& part = parts[idx];
+        TRACE_SCOPE("merge_part", "io",
+                    utils::Tracer::Enabled()
+                        ? "\"part\":" + std::to_string(idx)
+                        : std::string());
+        int srcFd = open(part.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (srcFd < 0 || fstat(srcFd, &st) != 0 ||
+            static_cast<uint64_t>(st.st_size) != part.length) {
+          LOG(ERROR) << "Part file " << part.path << " missing or not "
+                     << part.length << " bytes";
+          if (srcFd >= 0) close(srcFd);
+          ok = false;
+          return;
+        }
+
+        bool placed = false;
+        const int last = static_cast<int>(MergeMethod::ReadWrite);
+        for (int m = floor.load(); m <= last; ++m) {
+          auto method = static_cast<MergeMethod>(m);
+          switch (method) {
+            case MergeMethod::Reflink:
+              placed = cloneRange(srcFd, destFd, part);
+              break;
+            case MergeMethod::CopyFileRange:
+              placed = copyRange(srcFd, destFd, part);
+              break;
+            case MergeMethod::ReadWrite:
+              placed = readWriteRange(srcFd, destFd, part);
+              break;
+          }
+          if (placed) {
+            ++used[m];
+            break;
+          }
+          int err = errno;
+          if (method == MergeMethod::ReadWrite || !unsupported(err)) {
+            LOG(ERROR) << "Failed to merge " << part.path << " via "
+                       << MergeMethodName(method) << ": "
+                       << std::strerror(err);
+            break;
+          }
+          // 未对齐的分片会让 reflink 返回 EINVAL，只对该分片回退
+          if (!(method == MergeMethod::Reflink && err == EINVAL)) {
+            int expected = m;
+            floor.compare_exchange_strong(expected, m + 1);
+          }
+        }
+        close(srcFd);
+        if (!placed) ok = false;
+      });
+
+  if (close(destFd) != 0) ok = false;
+  if (ok && rename(tempPath.c_str(), dest.c_str()) != 0) {
+    LOG(ERROR) << "Failed to rename " << tempPath << " to " << dest << ": "
+               << std::strerror(errno);
+    ok = false;
+  }
+  if (!ok) {
+    unlink(tempPath.c_str());
+    return false;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+  LOG(INFO) << "Merged " << parts.size() << " parts (" << total
+            << " bytes) into " << dest << " in " << seconds << " s: "
+            << used[0] << " reflink, " << used[1] << " copy_file_range, "
+            << used[2] << " read/write";
+  return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef FILE_MERGER_HPP_
+#define FILE_MERGER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 一个分片文件及其在目标文件中的位置
+struct MergePart {
+  std::string path;
+  uint64_t offset;
+  uint64_t length;
+};
+
+// 按代价从低到高排列，合并时从指定方式开始逐级回退
+enum class MergeMethod { Reflink, CopyFileRange, ReadWrite };
+
+const char* MergeMethodName(MergeMethod method);
+
+/**
+ * @brief 分片合并：预分配临时文件后并行把各分片放到对应偏移，
+ *        全部成功才改名为目标文件，
+ *        优先 FICLONERANGE 共享数据块（XFS/btrfs 上几乎零拷贝），
+ *        不支持时用 copy_file_range 在内核内拷贝，最后回退到用户态读写
+ */
+class FileMerger {
+ public:
+  // 全部分片写入成功时返回 true，不删除分片文件；失败时 dest 保持原样
+  static bool Merge(const std::string& dest,
+                    const std::vector<MergePart>& parts,
+                    MergeMethod preferred = MergeMethod::Reflink);
+};
+
+#endif  // FILE_MERGER_HPP_
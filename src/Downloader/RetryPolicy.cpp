@@ -0,0 +1,57 @@
+#include "RetryPolicy.hpp"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <random>
+
+DECLARE_int32(max_retries);
+DECLARE_int32(retry_base_delay_ms);
+DECLARE_int32(retry_max_delay_ms);
+
+RetryPolicy RetryPolicy::FromFlags() {
+  RetryPolicy policy;
+  policy.maxRetries = std::max(0, FLAGS_max_retries);
+  policy.baseDelay =
+      std::chrono::milliseconds(std::max(1, FLAGS_retry_base_delay_ms));
+  policy.maxDelay = std::chrono::milliseconds(
+      std::max(FLAGS_retry_base_delay_ms, FLAGS_retry_max_delay_ms));
+  return policy;
+}
+
+bool RetryPolicy::isRetryable(CURLcode res, long httpCode) const {
+  switch (res) {
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+      return true;
+    case CURLE_HTTP_RETURNED_ERROR:
+      return httpCode >= 500 || httpCode == 408 || httpCode == 429;
+    default:
+      return false;
+  }
+}
+
+std::chrono::milliseconds RetryPolicy::nextDelay(int attempt,
+                                                 long retryAfterSec) const {
+  if (retryAfterSec > 0) {
+    // 服务端要求的等待同样受 maxDelay 约束，避免分片被挂起数小时
+    return std::min(maxDelay, std::chrono::milliseconds(
+                                  std::min(retryAfterSec, 86400L) * 1000));
+  }
+  // 抖动：在 [base, min(max, base * 2^(attempt-1))] 内均匀取值，
+  // 避免所有分片同时失败后又同时重连
+  int shift = std::min(std::max(attempt - 1, 0), 20);
+  long long base = baseDelay.count();
+  long long cap = std::min<long long>(maxDelay.count(), base << shift);
+  thread_local std::mt19937_64 rng{std::random_device{}()};
+  std::uniform_int_distribution<long long> dist(base, std::max(cap, base));
+  return std::chrono::milliseconds(dist(rng));
+}
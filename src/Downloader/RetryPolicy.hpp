@@ -0,0 +1,27 @@
+#ifndef RETRY_POLICY_HPP_
+#define RETRY_POLICY_HPP_
+
+#include <curl/curl.h>
+
+#include <chrono>
+
+/**
+ * @brief 分片重试策略：错误分类 + 带抖动的指数退避
+ */
+struct RetryPolicy {
+  int maxRetries = 5;                             // 单个分片最大重试次数
+  std::chrono::milliseconds baseDelay{500};       // 首次退避基准
+  std::chrono::milliseconds maxDelay{30 * 1000};  // 退避上限
+
+  // 从 gflags 读取配置
+  static RetryPolicy FromFlags();
+
+  // 判断错误是否值得重试（超时、连接中断、5xx、408、429）
+  bool isRetryable(CURLcode res, long httpCode) const;
+
+  // 计算第 attempt 次重试（从 1 开始）前的等待时间
+  // retryAfterSec > 0 时优先使用服务端给出的 Retry-After，上限仍为 maxDelay
+  std::chrono::milliseconds nextDelay(int attempt, long retryAfterSec) const;
+};
+
+#endif  // RETRY_POLICY_HPP_
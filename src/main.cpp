@@ -1,21 +1,94 @@
 #include <gflags/gflags.h>
+#include <unistd.h>
 
 #include <iostream>
+#include <string>
 
+#include "Downloader/BatchDownloader.hpp"
+#include "Downloader/DistCoordinator.hpp"
+#include "Downloader/DistWorker.hpp"
 #include "Downloader/Downloader.hpp"
 #include "utils/logger.hpp"
+#include "utils/trace.hpp"
 
 DEFINE_int32(download_threads, 0,
              "Number of download threads (0 for max concurrency)");
 DEFINE_string(custom_tbb_parallel_control, "",
               "TBB arena concurrency control, e.g. arena1:4,arena2:8");
+DEFINE_int32(max_retries, 5, "Max retries per chunk on retryable errors");
+DEFINE_int32(retry_base_delay_ms, 500, "Base delay of exponential backoff");
+DEFINE_int32(retry_max_delay_ms, 30000, "Upper bound of backoff delay");
+DEFINE_string(input_list, "",
+              "Batch mode: file with one '<url> <location>' pair per line");
+DEFINE_int32(batch_concurrency, 64, "Concurrent transfers in batch mode");
+DEFINE_int32(max_host_connections, 8,
+             "Max connections kept per host in batch mode");
+DEFINE_int64(small_file_threshold, 8 * 1024 * 1024,
+             "Files up to this size skip HEAD and range splitting");
+DEFINE_string(dist_role, "",
+              "Distributed mode: 'coordinator' or 'worker' (empty: local)");
+DEFINE_string(dist_socket, "", "Unix socket path of the coordinator");
+DEFINE_int32(dist_workers, 0,
+             "Worker processes the coordinator spawns (0: external only)");
+DEFINE_int64(lease_size, 16 * 1024 * 1024, "Bytes per range lease");
+DEFINE_int32(lease_timeout_ms, 10000,
+             "Reassign a lease after this long without a heartbeat");
+DEFINE_int32(heartbeat_interval_ms, 1000, "Worker heartbeat interval");
+DEFINE_int32(dist_idle_timeout_ms, 60000,
+             "Coordinator gives up after this long with no worker connected");
+DEFINE_string(trace_file, "",
+              "Write Chrome trace-event JSON (Perfetto) to this path on exit");
+
+namespace {
+
+// 按命令行选择的模式执行下载，成功返回 true
+bool runMode(char* argv[]) {
+  if (FLAGS_dist_role == "worker") {
+    DistWorker worker(FLAGS_dist_socket);
+    return worker.run();
+  }
+  if (FLAGS_dist_role == "coordinator") {
+    std::string socketPath =
+        FLAGS_dist_socket.empty()
+            ? "/tmp/downloader_" + std::to_string(getpid()) + ".sock"
+            : FLAGS_dist_socket;
+    DistCoordinator coordinator(socketPath);
+    return coordinator.run(argv[1], argv[2]);
+  }
+
+  Downloader downloader;
+  if (!FLAGS_input_list.empty()) {
+    BatchDownloader batch(downloader);
+    return batch.run(FLAGS_input_list);
+  }
+
+  std::string userUrl = argv[1];
+  std::string location = argv[2];
+
+  return downloader.startDownload(userUrl, location, FLAGS_download_threads);
+}
+
+}  // namespace
 
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  if (argc != 3) {
+  bool batchMode = !FLAGS_input_list.empty();
+  bool workerMode = FLAGS_dist_role == "worker";
+  bool distMode = workerMode || FLAGS_dist_role == "coordinator";
+  // 未知角色、批量与分布式模式混用、位置参数个数不符都直接报用法
+  bool validMode = (FLAGS_dist_role.empty() || distMode) &&
+                   !(batchMode && distMode) &&
+                   !(workerMode && FLAGS_dist_socket.empty());
+  if (!validMode || ((batchMode || workerMode) ? argc != 1 : argc != 3)) {
     std::cerr << "Usage: " << argv[0]
-              << " <user@url> <location> [--download_threads=N]" << std::endl;
+              << " <user@url> <location> [--download_threads=N]\n"
+              << "       " << argv[0] << " --input_list=<file>\n"
+              << "       " << argv[0]
+              << " <url> <location> --dist_role=coordinator"
+                 " [--dist_workers=N] [--dist_socket=<path>]\n"
+              << "       " << argv[0]
+              << " --dist_role=worker --dist_socket=<path>" << std::endl;
     return 1;
   }
 
@@ -26,11 +99,18 @@ int main(int argc, char* argv[]) {
   logCfg.maxBackupFiles = 3;
   utils::Logger::initialize(logCfg);
 
-  std::string userUrl = argv[1];
-  std::string location = argv[2];
+  if (!FLAGS_trace_file.empty()) {
+    utils::Tracer::GetInstance().Enable();
+  }
 
-  Downloader downloader;
-  downloader.startDownload(userUrl, location, FLAGS_download_threads);
+  bool ok = runMode(argv);
 
-  return 0;
-}
\ No newline at end of file
+  if (!FLAGS_trace_file.empty()) {
+    // 工作进程各自写一份，避免互相覆盖
+    std::string tracePath =
+        workerMode ? FLAGS_trace_file + "." + std::to_string(getpid())
+                   : FLAGS_trace_file;
+    utils::Tracer::GetInstance().Flush(tracePath);
+  }
+  return ok ? 0 : 1;
+}
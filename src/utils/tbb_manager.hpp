@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "logger.hpp"
+#include "trace.hpp"
 
 DECLARE_string(custom_tbb_parallel_control);
 
@@ -50,6 +51,10 @@ class TBBManager {
   void ParallelFor(const std::string& tbb_name,
                    const tbb::blocked_range<T>& range, const Func& task);
 
+  // 异步投递单个任务到指定arena，调用线程不等待任务完成
+  template <typename Func>
+  void Enqueue(const std::string& tbb_name, Func task);
+
   void Release();
   ~TBBManager();
 
@@ -92,6 +97,13 @@ void TBBManager::ParallelFor(const std::string& tbb_name, IntType start,
             tbb::blocked_range<IntType>(start, end),
             [this, task, tbb_name, task_id,
              unique_task_name](const tbb::blocked_range<IntType>& range) {
+              TRACE_SCOPE("ParallelFor", "tbb",
+                          Tracer::Enabled()
+                              ? "\"task\":\"" + unique_task_name +
+                                    "\",\"begin\":" +
+                                    std::to_string(range.begin()) +
+                                    ",\"end\":" + std::to_string(range.end())
+                              : std::string());
               std::vector<ThreadContext> local_contexts;
               local_contexts.reserve(range.size());
               for (IntType i = range.begin(); i < range.end(); ++i) {
@@ -128,6 +140,10 @@ void TBBManager::ParallelFor(const std::string& tbb_name,
   arena->execute([this, &task, &range, tbb_name, task_id, unique_task_name]() {
     tbb::parallel_for(range, [this, &task, tbb_name, task_id, unique_task_name](
                                  const tbb::blocked_range<T>& sub_range) {
+      TRACE_SCOPE("ParallelFor", "tbb",
+                  Tracer::Enabled()
+                      ? "\"task\":\"" + unique_task_name + "\""
+                      : std::string());
       std::vector<ThreadContext> local_contexts;
       local_contexts.reserve(sub_range.size());
       for (auto it = sub_range.begin(); it != sub_range.end(); ++it) {
@@ -147,6 +163,18 @@ void TBBManager::ParallelFor(const std::string& tbb_name,
   LOG(INFO) << "[TBBManager] ParallelFor end: " << unique_task_name;
 }
 
+template <typename Func>
+void TBBManager::Enqueue(const std::string& tbb_name, Func task) {
+  auto arena = Init(tbb_name);
+  arena->enqueue([task = std::move(task)]() {
+    try {
+      task();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "[TBBManager] Exception in enqueued task: " << e.what();
+    }
+  });
+}
+
 #define ARENA_TBB_WITH_GFLAGS_PARALLEL_FOR(gflagsName, ...)                 \
   do {                                                                      \
     utils::TBBManager::GetInstance().ParallelFor(#gflagsName, __VA_ARGS__); \
@@ -63,10 +63,11 @@ void Timer::start() {
           std::this_thread::yield();
           lock.lock();
         } else {
+          // 只有更早的新任务才需要提前唤醒；用 <= 会让队首任务自身满足条件而空转
           tasksCv_.wait_until(
               lock, nextTask.execTimestamp, [this, &nextTask]() {
                 return !running_ ||
-                       (!taskQueue_.empty() && taskQueue_.top().execTimestamp <=
+                       (!taskQueue_.empty() && taskQueue_.top().execTimestamp <
                                                    nextTask.execTimestamp);
               });
         }
@@ -0,0 +1,129 @@
+#include "trace.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+
+#include "logger.hpp"
+
+namespace utils {
+
+namespace {
+const auto trace_epoch = std::chrono::steady_clock::now();
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+thread_local Tracer::ThreadBuffer* Tracer::localBuffer_ = nullptr;
+
+Tracer& Tracer::GetInstance() {
+  static Tracer instance;
+  return instance;
+}
+
+Tracer::Tracer() {}
+
+void Tracer::Enable() { enabled_.store(true, std::memory_order_relaxed); }
+
+uint64_t Tracer::NowUs() const {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - trace_epoch)
+          .count());
+}
+
+Tracer::ThreadBuffer* Tracer::LocalBuffer() {
+  if (!localBuffer_) {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->events.reserve(1024);
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    buffer->tid = static_cast<uint32_t>(buffers_.size() + 1);
+    localBuffer_ = buffer.get();
+    buffers_.push_back(std::move(buffer));
+  }
+  return localBuffer_;
+}
+
+void Tracer::AddSpan(const char* name, const char* cat, uint64_t tsUs,
+                     uint64_t durUs, std::string args) {
+  if (!Enabled()) return;
+  LocalBuffer()->events.push_back(
+      TraceEvent{name, cat, tsUs, durUs, std::move(args)});
+}
+
+bool Tracer::Flush(const std::string& path) {
+  std::lock_guard<std::mutex> lock(buffersMutex_);
+  std::ofstream ofs(path, std::ios::trunc);
+  if (!ofs) {
+    LOG(ERROR) << "[Tracer] Failed to open trace file: " << path;
+    return false;
+  }
+  size_t count = 0;
+  const char* sep = "\n";
+  ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (const auto& buffer : buffers_) {
+    ofs << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << getpid()
+        << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"thread-"
+        << buffer->tid << "\"}}";
+    sep = ",\n";
+    for (const auto& ev : buffer->events) {
+      ofs << sep << "{\"name\":\"" << ev.name << "\",\"cat\":\"" << ev.cat
+          << "\",\"ph\":\"X\",\"ts\":" << ev.tsUs << ",\"dur\":" << ev.durUs
+          << ",\"pid\":" << getpid() << ",\"tid\":" << buffer->tid
+          << ",\"args\":{" << ev.args << "}}";
+    }
+    count += buffer->events.size();
+  }
+  ofs << "\n]}\n";
+  ofs.close();
+  if (!ofs) {
+    LOG(ERROR) << "[Tracer] Failed to write trace file: " << path;
+    return false;
+  }
+  LOG(INFO) << "[Tracer] Wrote " << count << " events to " << path;
+  return true;
+}
+
+TraceScope::TraceScope(const char* name, const char* cat, std::string args)
+    : name_(name), cat_(cat), beginUs_(0), active_(Tracer::Enabled()) {
+  if (active_) {
+    args_ = std::move(args);
+    beginUs_ = Tracer::GetInstance().NowUs();
+  }
+}
+
+TraceScope::~TraceScope() {
+  if (!active_) return;
+  auto& tracer = Tracer::GetInstance();
+  tracer.AddSpan(name_, cat_, beginUs_, tracer.NowUs() - beginUs_,
+                 std::move(args_));
+}
+
+SpanAccumulator::SpanAccumulator(const char* name, const char* cat)
+    : name_(name), cat_(cat), active_(Tracer::Enabled()) {}
+
+uint64_t SpanAccumulator::Begin() const {
+  return active_ ? Tracer::GetInstance().NowUs() : 0;
+}
+
+void SpanAccumulator::End(uint64_t beginUs, uint64_t bytes) {
+  if (!active_) return;
+  if (calls_ == 0) firstUs_ = beginUs;
+  totalUs_ += Tracer::GetInstance().NowUs() - beginUs;
+  ++calls_;
+  bytes_ += bytes;
+}
+
+void SpanAccumulator::Record(const std::string& args) {
+  if (!active_ || calls_ == 0) return;
+  std::string all = args.empty() ? std::string() : args + ",";
+  all += "\"calls\":" + std::to_string(calls_) +
+         ",\"bytes\":" + std::to_string(bytes_);
+  Tracer::GetInstance().AddSpan(name_, cat_, firstUs_, totalUs_,
+                                std::move(all));
+  calls_ = 0;
+  totalUs_ = 0;
+  bytes_ = 0;
+}
+
+}  // namespace utils
@@ -0,0 +1,109 @@
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+struct TraceEvent {
+  const char* name;  // 需为静态字符串
+  const char* cat;
+  uint64_t tsUs;
+  uint64_t durUs;
+  std::string args;  // JSON 对象内部，如 "\"chunk\":3"，可为空
+};
+
+/**
+ * @brief 轻量级追踪器，记录 begin/end span 并导出为 Chrome trace-event JSON
+ *        （可在 Perfetto / chrome://tracing 中查看）
+ *
+ * 每个线程首次记录时注册一个私有缓冲区，之后追加事件无需加锁；
+ * Flush 应在所有工作完成后调用。
+ */
+class Tracer {
+ public:
+  static Tracer& GetInstance();
+
+  static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+  void Enable();
+
+  // 相对追踪器启动时刻的微秒数
+  uint64_t NowUs() const;
+
+  void AddSpan(const char* name, const char* cat, uint64_t tsUs,
+               uint64_t durUs, std::string args = std::string());
+
+  // 写出所有线程缓冲区中的事件，成功返回 true
+  bool Flush(const std::string& path);
+
+ private:
+  struct ThreadBuffer {
+    uint32_t tid;
+    std::vector<TraceEvent> events;
+  };
+
+  Tracer();
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  ThreadBuffer* LocalBuffer();
+
+  static std::atomic<bool> enabled_;
+  static thread_local ThreadBuffer* localBuffer_;
+  std::mutex buffersMutex_;  // 仅在线程注册缓冲区和 Flush 时使用
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// RAII span：构造时记录开始，析构时写入当前线程缓冲区
+class TraceScope {
+ public:
+  TraceScope(const char* name, const char* cat,
+             std::string args = std::string());
+  ~TraceScope();
+
+ private:
+  const char* name_;
+  const char* cat_;
+  std::string args_;
+  uint64_t beginUs_;
+  bool active_;
+};
+
+// 把高频的短操作（如 curl 每次写回调）累加成一个 span，避免逐次记录事件：
+// ts 为首次开始时刻，dur 为各次耗时之和，args 附带次数和字节数
+class SpanAccumulator {
+ public:
+  SpanAccumulator(const char* name, const char* cat);
+
+  // 返回本次开始时刻，未开启追踪时为 0
+  uint64_t Begin() const;
+  void End(uint64_t beginUs, uint64_t bytes);
+
+  // 有累计时写入当前线程缓冲区并清零
+  void Record(const std::string& args = std::string());
+
+ private:
+  const char* name_;
+  const char* cat_;
+  bool active_;
+  uint64_t firstUs_ = 0;
+  uint64_t totalUs_ = 0;
+  uint64_t calls_ = 0;
+  uint64_t bytes_ = 0;
+};
+
+}  // namespace utils
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// 用法：TRACE_SCOPE("merge", "io");
+#define TRACE_SCOPE(...) \
+  utils::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+
+#endif  // TRACE_HPP_